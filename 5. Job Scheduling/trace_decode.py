@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+#
+# File        : trace_decode.py
+#
+# Description : Host-side decoder for the output of Trace::dump().
+#
+#               The kernel writes the trace to port 0xE9. Capture it with
+#                   bochs -q -f bochsrc.bxrc > out.txt       (port_e9_hack)
+#                   qemu-system-i386 ... -debugcon file:out.txt
+#               and run
+#                   python3 trace_decode.py out.txt [--events] [--dump N]
+#
+#               It prints, for every event type, the count, mean and
+#               maximum time, percentiles and the latency histogram; with
+#               --events, also the events still in the rings, merged into
+#               one timeline. Console output around the trace is ignored.
+#               If the kernel dumped more than once, --dump picks the dump
+#               (default: the last one).
+
+import sys
+import argparse
+
+
+class Event:
+    def __init__(self, name, count, total, max_cycles):
+        self.name = name
+        self.count = count
+        self.total = total
+        self.max_cycles = max_cycles
+        self.histogram = []
+        self.records = []   # (tsc, cycles, arg)
+
+
+def parse(lines):
+    """Return a list of dumps, each a (khz, {event id: Event}) pair."""
+    dumps = []
+    khz, events = None, None
+    for line in lines:
+        at = line.find('@TRACE ')
+        if at < 0:
+            continue
+        fields = line[at:].split()[1:]
+        if not fields:
+            continue
+        kind, args = fields[0], fields[1:]
+        try:
+            if kind == 'BEGIN':
+                khz, events = int(args[0], 16), {}
+            elif events is None:
+                continue
+            elif kind == 'EVENT':
+                e = int(args[0], 16)
+                total = (int(args[3], 16) << 32) | int(args[4], 16)
+                events[e] = Event(args[1], int(args[2], 16), total, int(args[5], 16))
+            elif kind == 'HIST':
+                events[int(args[0], 16)].histogram = [int(x, 16) for x in args[1:]]
+            elif kind == 'REC':
+                e = int(args[0], 16)
+                tsc = (int(args[1], 16) << 32) | int(args[2], 16)
+                events[e].records.append((tsc, int(args[3], 16), int(args[4], 16)))
+            elif kind == 'END':
+                dumps.append((khz, events))
+                khz, events = None, None
+        except (IndexError, KeyError, ValueError):
+            sys.stderr.write('trace_decode: skipping bad line: %s\n' % line.rstrip())
+    if events is not None:
+        sys.stderr.write('trace_decode: last dump is incomplete\n')
+        dumps.append((khz, events))
+    return dumps
+
+
+def us(cycles, khz):
+    return cycles * 1000.0 / khz if khz else 0.0
+
+
+def percentile(histogram, fraction):
+    """Upper bound, in cycles, of the bucket that holds the given fraction."""
+    total = sum(histogram)
+    seen = 0
+    for bucket, n in enumerate(histogram):
+        seen += n
+        if total and seen >= fraction * total:
+            return (1 << (bucket + 1)) - 1
+    return 0
+
+
+def report(khz, events, show_events):
+    print('TSC at %d kHz' % khz)
+    print()
+    print('%-15s %9s %12s %12s %10s %10s %10s' %
+          ('event', 'count', 'mean us', 'max us', 'p50 us', 'p90 us', 'p99 us'))
+    for e in sorted(events):
+        ev = events[e]
+        mean = ev.total / ev.count if ev.count else 0
+        print('%-15s %9d %12.2f %12.2f %10.2f %10.2f %10.2f' %
+              (ev.name, ev.count, us(mean, khz), us(ev.max_cycles, khz),
+               us(percentile(ev.histogram, 0.50), khz),
+               us(percentile(ev.histogram, 0.90), khz),
+               us(percentile(ev.histogram, 0.99), khz)))
+
+    for e in sorted(events):
+        ev = events[e]
+        print()
+        print('%s, cycles:' % ev.name)
+        peak = max(ev.histogram) if ev.histogram else 0
+        for bucket, n in enumerate(ev.histogram):
+            if n == 0:
+                continue
+            bar = '#' * max(1, n * 50 // peak)
+            print('  %10d .. %-10d %8d %s' % (1 << bucket if bucket else 0,
+                                             (1 << (bucket + 1)) - 1, n, bar))
+
+    if show_events:
+        timeline = [(tsc, events[e].name, cycles, arg)
+                    for e in events for (tsc, cycles, arg) in events[e].records]
+        timeline.sort()
+        print()
+        print('%14s %-15s %12s  %s' % ('time us', 'event', 'took us', 'arg'))
+        if timeline:
+            t0 = timeline[0][0]
+            for tsc, name, cycles, arg in timeline:
+                print('%14.2f %-15s %12.2f  0x%x' %
+                      (us(tsc - t0, khz), name, us(cycles, khz), arg))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode a kernel trace dump.')
+    parser.add_argument('file', nargs='?', help='emulator output (default: stdin)')
+    parser.add_argument('--events', action='store_true',
+                        help='list the events in the rings, oldest first')
+    parser.add_argument('--dump', type=int, default=-1,
+                        help='which dump to decode, counting from 0 (default: last)')
+    args = parser.parse_args()
+
+    if args.file:
+        with open(args.file, errors='replace') as f:
+            dumps = parse(f)
+    else:
+        dumps = parse(sys.stdin)
+
+    if not dumps:
+        sys.exit('trace_decode: no trace found')
+    try:
+        khz, events = dumps[args.dump]
+    except IndexError:
+        sys.exit('trace_decode: there are only %d dumps' % len(dumps))
+    report(khz, events, args.events)
+
+
+if __name__ == '__main__':
+    main()
@@ -15,4 +15,18 @@ global _get_EFLAGS
 _get_EFLAGS:
 	pushfd			; push eflags
 	pop	eax		; pop contents into eax
-	ret
\ No newline at end of file
+	ret
+; ----------------------------------------------------------------------
+; xchg(volatile unsigned long * _address, unsigned long _value)
+;
+; Atomically stores _value at _address and returns the old value.
+; (XCHG with a memory operand is always locked.)
+;
+; ----------------------------------------------------------------------
+global _xchg
+; this function is exported.
+_xchg:
+	mov	edx, [esp+4]	; address
+	mov	eax, [esp+8]	; new value
+	xchg	[edx], eax	; old value into eax
+	ret